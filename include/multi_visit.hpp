@@ -0,0 +1,445 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+template<typename... Ts>
+struct overloaded : Ts... { using Ts::operator()...; };
+
+template<typename... Ts>
+overloaded(Ts...) -> overloaded<Ts...>;
+
+template<typename T>
+struct is_variant : std::false_type {};
+
+template<typename... Ts>
+struct is_variant<std::variant<Ts...>> : std::true_type {};
+
+template<typename T>
+inline constexpr bool is_variant_v = is_variant<T>::value;
+
+template<typename Tuple, typename F, std::size_t... Is>
+constexpr decltype(auto) apply_with_index_impl(F&& f, Tuple&& t, std::index_sequence<Is...>) {
+    return std::forward<F>(f)(std::get<Is>(std::forward<Tuple>(t))...);
+}
+
+template<typename Tuple, typename F>
+constexpr decltype(auto) apply_with_index(F&& f, Tuple&& t) {
+    return apply_with_index_impl(
+        std::forward<F>(f), 
+        std::forward<Tuple>(t),
+        std::make_index_sequence<std::tuple_size_v<std::remove_reference_t<Tuple>>>{}
+    );
+}
+
+template<typename Visitor, typename Tuple, std::size_t I = 0>
+struct VariantTupleVisitor {
+    template<typename... Args>
+    static constexpr decltype(auto) visit(Visitor&& visitor, Tuple&& tuple, Args&&... args) {
+        if constexpr (I == std::tuple_size_v<std::remove_reference_t<Tuple>>) {
+            return std::forward<Visitor>(visitor)(std::forward<Args>(args)...);
+        } else {
+            return std::visit([&](auto&& val) -> decltype(auto) {
+                return VariantTupleVisitor<Visitor, Tuple, I + 1>::visit(
+                    std::forward<Visitor>(visitor),
+                    std::forward<Tuple>(tuple),
+                    std::forward<Args>(args)...,
+                    std::forward<decltype(val)>(val)
+                );
+            }, std::get<I>(std::forward<Tuple>(tuple)));
+        }
+    }
+};
+
+template<typename F, typename... Variants>
+constexpr decltype(auto) multi_visit(F&& f, Variants&&... variants) {
+    static_assert((is_variant_v<std::remove_cvref_t<Variants>> && ...));
+    return VariantTupleVisitor<F, std::tuple<Variants...>>::visit(
+        std::forward<F>(f),
+        std::forward_as_tuple(std::forward<Variants>(variants)...)
+    );
+}
+
+template<typename F, typename Tuple>
+constexpr decltype(auto) multi_visit_tuple(F&& f, Tuple&& tuple) {
+    return apply_with_index([&f](auto&&... variants) -> decltype(auto) {
+        return multi_visit(std::forward<F>(f), std::forward<decltype(variants)>(variants)...);
+    }, std::forward<Tuple>(tuple));
+}
+
+struct symmetric_slot {
+    std::size_t lo;
+    std::size_t hi;
+};
+
+constexpr symmetric_slot symmetric_slot_of(std::size_t k) {
+    std::size_t hi = 0;
+    while ((hi + 1) * (hi + 2) / 2 <= k) {
+        ++hi;
+    }
+    return {k - hi * (hi + 1) / 2, hi};
+}
+
+constexpr std::size_t symmetric_slot_index(std::size_t lo, std::size_t hi) {
+    return hi * (hi + 1) / 2 + lo;
+}
+
+template<typename F, typename Lo, typename Hi, std::size_t K>
+constexpr decltype(auto) symmetric_invoke(F&& f, Lo&& lo, Hi&& hi, bool swapped) {
+    constexpr symmetric_slot slot = symmetric_slot_of(K);
+    return std::forward<F>(f)(
+        std::get<slot.lo>(std::forward<Lo>(lo)),
+        std::get<slot.hi>(std::forward<Hi>(hi)),
+        swapped
+    );
+}
+
+template<typename F, typename Lo, typename Hi, std::size_t... Ks>
+constexpr decltype(auto) symmetric_dispatch(std::size_t k, F&& f, Lo&& lo, Hi&& hi, bool swapped,
+                                            std::index_sequence<Ks...>) {
+    using R = decltype(symmetric_invoke<F, Lo, Hi, 0>(
+        std::declval<F>(), std::declval<Lo>(), std::declval<Hi>(), false));
+    constexpr R (*table[])(F&&, Lo&&, Hi&&, bool) = { &symmetric_invoke<F, Lo, Hi, Ks>... };
+    return table[k](std::forward<F>(f), std::forward<Lo>(lo), std::forward<Hi>(hi), swapped);
+}
+
+// Visits two variants of the same type as an unordered pair: the handler is
+// called as f(lo, hi, swapped) with index(lo) <= index(hi), so only
+// N(N+1)/2 alternative combinations are instantiated instead of N².
+// Arguments of differing cv/ref qualification are both bound as lvalues,
+// const if either is const, so a single table serves every call.
+template<typename F, typename L, typename R>
+constexpr decltype(auto) multi_visit_symmetric(F&& f, L&& lhs, R&& rhs) {
+    using V = std::remove_cvref_t<L>;
+    static_assert(is_variant_v<V>);
+    static_assert(std::is_same_v<V, std::remove_cvref_t<R>>,
+                  "multi_visit_symmetric requires both arguments to have the same variant type");
+    if constexpr (!std::is_same_v<L, R>) {
+        using Common = std::conditional_t<
+            std::is_const_v<std::remove_reference_t<L>> || std::is_const_v<std::remove_reference_t<R>>,
+            const V&,
+            V&
+        >;
+        return multi_visit_symmetric(std::forward<F>(f), static_cast<Common>(lhs), static_cast<Common>(rhs));
+    } else {
+        if (lhs.valueless_by_exception() || rhs.valueless_by_exception()) {
+            throw std::bad_variant_access{};
+        }
+        constexpr std::size_t N = std::variant_size_v<V>;
+        const bool swapped = rhs.index() < lhs.index();
+        auto&& lo = swapped ? rhs : lhs;
+        auto&& hi = swapped ? lhs : rhs;
+        return symmetric_dispatch(
+            symmetric_slot_index(lo.index(), hi.index()),
+            std::forward<F>(f),
+            std::forward<L>(lo),
+            std::forward<R>(hi),
+            swapped,
+            std::make_index_sequence<N * (N + 1) / 2>{}
+        );
+    }
+}
+
+template<typename T, typename = void>
+struct has_call_operator : std::false_type {};
+
+template<typename T>
+struct has_call_operator<T, std::void_t<decltype(&T::operator())>> : std::true_type {};
+
+template<typename F, typename... Args>
+struct is_invocable_impl : std::false_type {};
+
+template<typename F, typename... Args>
+struct is_invocable_impl<F, std::enable_if_t<std::is_invocable_v<F, Args...>>, Args...> : std::true_type {};
+
+struct unknown_result {};
+struct no_common_result {};
+
+template<typename T>
+struct member_call_result { using type = unknown_result; };
+
+template<typename C, typename R, typename... Ps>
+struct member_call_result<R (C::*)(Ps...)> { using type = R; };
+
+template<typename C, typename R, typename... Ps>
+struct member_call_result<R (C::*)(Ps...) const> { using type = R; };
+
+template<typename C, typename R, typename... Ps>
+struct member_call_result<R (C::*)(Ps...) noexcept> { using type = R; };
+
+template<typename C, typename R, typename... Ps>
+struct member_call_result<R (C::*)(Ps...) const noexcept> { using type = R; };
+
+// Return type of a functor with a single, non-template call operator;
+// unknown_result for generic lambdas and overload sets.
+template<typename T, typename = void>
+struct call_result { using type = unknown_result; };
+
+template<typename T>
+struct call_result<T, std::enable_if_t<has_call_operator<T>::value>> : member_call_result<decltype(&T::operator())> {};
+
+template<typename Acc, typename T>
+struct join_result { using type = no_common_result; };
+
+template<typename Acc, typename T>
+    requires requires { typename std::common_type<Acc, T>::type; }
+struct join_result<Acc, T> { using type = std::common_type_t<Acc, T>; };
+
+template<typename T>
+struct join_result<unknown_result, T> { using type = T; };
+
+template<typename Acc>
+struct join_result<Acc, unknown_result> { using type = Acc; };
+
+template<>
+struct join_result<unknown_result, unknown_result> { using type = unknown_result; };
+
+template<typename Acc, typename... Fs>
+struct declared_result { using type = Acc; };
+
+template<typename Acc, typename F, typename... Fs>
+struct declared_result<Acc, F, Fs...>
+    : declared_result<typename join_result<Acc, typename call_result<F>::type>::type, Fs...> {};
+
+template<typename Tuple, std::size_t... Is>
+constexpr auto tuple_transform_impl(Tuple&& t, auto&& f, std::index_sequence<Is...>) {
+    return std::make_tuple(f(std::get<Is>(std::forward<Tuple>(t)))...);
+}
+
+template<typename Tuple, typename F>
+constexpr auto tuple_transform(Tuple&& t, F&& f) {
+    return tuple_transform_impl(
+        std::forward<Tuple>(t),
+        std::forward<F>(f),
+        std::make_index_sequence<std::tuple_size_v<std::remove_reference_t<Tuple>>>{}
+    );
+}
+
+
+// A MultiDispatcher case that only matches when Pred accepts the arguments.
+// Cases sharing a named, stateless Pred type evaluate it once per call;
+// every lambda has its own type, so lambda guards are never shared.
+template<typename Pred, typename F>
+struct guarded {
+    Pred pred;
+    F handler;
+};
+
+template<typename Pred, typename F>
+guarded(Pred, F) -> guarded<Pred, F>;
+
+template<typename Pred, typename F>
+constexpr guarded<Pred, F> when(Pred pred, F handler) {
+    return {std::move(pred), std::move(handler)};
+}
+
+template<typename T>
+struct is_guarded : std::false_type {};
+
+template<typename Pred, typename F>
+struct is_guarded<guarded<Pred, F>> : std::true_type {};
+
+template<typename T>
+inline constexpr bool is_guarded_v = is_guarded<T>::value;
+
+template<typename T>
+struct case_traits {
+    using guard = void;
+    using handler = T;
+};
+
+template<typename Pred, typename F>
+struct case_traits<guarded<Pred, F>> {
+    using guard = Pred;
+    using handler = F;
+};
+
+template<typename... Functors>
+class MultiDispatcher {
+    static constexpr std::size_t N = sizeof...(Functors);
+
+    std::tuple<Functors...> functors;
+
+    template<std::size_t I>
+    using case_t = std::tuple_element_t<I, std::tuple<Functors...>>;
+
+    template<std::size_t I>
+    static constexpr bool guarded_case = is_guarded_v<case_t<I>>;
+
+    template<std::size_t I>
+    using guard_t = typename case_traits<case_t<I>>::guard;
+
+    template<std::size_t I>
+    using handler_t = const typename case_traits<case_t<I>>::handler&;
+
+    template<std::size_t I, typename... Args>
+    static constexpr bool case_applies() {
+        if constexpr (guarded_case<I>) {
+            return std::is_invocable_v<handler_t<I>, Args...>
+                && std::is_invocable_r_v<bool, const guard_t<I>&, Args&...>;
+        } else {
+            return std::is_invocable_v<handler_t<I>, Args...>;
+        }
+    }
+
+    // Index of the first case whose guard has the same stateless type as
+    // case I; that guard's result is cached and reused for case I.
+    template<std::size_t I, std::size_t J = 0>
+    static constexpr std::size_t guard_slot() {
+        if constexpr (J == I) {
+            return I;
+        } else if constexpr (std::is_same_v<guard_t<I>, guard_t<J>> && std::is_empty_v<guard_t<I>>) {
+            return J;
+        } else {
+            return guard_slot<I, J + 1>();
+        }
+    }
+
+    // The cases reachable for Args, in declaration order: every guarded case
+    // whose handler accepts Args, up to the first unguarded one. Cases after
+    // that are never tested, so their bodies are never instantiated.
+    template<std::size_t I, typename... Args, std::size_t... Planned>
+    static constexpr auto make_plan(std::index_sequence<Planned...>) {
+        if constexpr (I == N) {
+            return std::index_sequence<Planned...>{};
+        } else if constexpr (!case_applies<I, Args...>()) {
+            return make_plan<I + 1, Args...>(std::index_sequence<Planned...>{});
+        } else if constexpr (guarded_case<I>) {
+            return make_plan<I + 1, Args...>(std::index_sequence<Planned..., I>{});
+        } else {
+            return std::index_sequence<Planned..., I>{};
+        }
+    }
+
+    template<typename... Args>
+    using plan_t = decltype(make_plan<0, Args...>(std::index_sequence<>{}));
+
+    using declared_result_t =
+        typename declared_result<unknown_result, typename case_traits<Functors>::handler...>::type;
+
+    static_assert(!std::is_same_v<declared_result_t, no_common_result>,
+                  "MultiDispatcher: the case handlers' return types have no common type");
+
+    template<typename R>
+    static auto wrap_result() {
+        if constexpr (std::is_void_v<R>) {
+            return std::optional<std::monostate>{};
+        } else {
+            return std::optional<std::remove_cvref_t<R>>{};
+        }
+    }
+
+    // Without a non-generic handler to fix the result type, it is taken from
+    // the reachable cases for each argument list.
+    template<typename... Args, std::size_t First, std::size_t... Rest>
+    static auto reachable_result(std::index_sequence<First, Rest...>) {
+        using R = std::invoke_result_t<handler_t<First>, Args...>;
+        static_assert((std::is_same_v<R, std::invoke_result_t<handler_t<Rest>, Args...>> && ...),
+                      "MultiDispatcher: all cases reachable for the same arguments must return the same type");
+        return wrap_result<R>();
+    }
+
+    template<typename... Args>
+    static auto reachable_result(std::index_sequence<>) {
+        return std::optional<std::monostate>{};
+    }
+
+    template<typename... Args, std::size_t... Is>
+    static auto dispatch_result(std::index_sequence<Is...> plan) {
+        if constexpr (std::is_same_v<declared_result_t, unknown_result>) {
+            return reachable_result<Args...>(plan);
+        } else {
+            static_assert((std::is_convertible_v<std::invoke_result_t<handler_t<Is>, Args...>, declared_result_t> && ...),
+                          "MultiDispatcher: every case must return a type convertible to the dispatcher's result type");
+            return wrap_result<declared_result_t>();
+        }
+    }
+
+public:
+    // std::optional of the common return type of the non-generic handlers, so
+    // every argument list, matched or not, yields the same type under
+    // multi_visit. Empty when no case accepts the arguments; void handlers
+    // yield std::monostate.
+    template<typename... Args>
+    using result_t = decltype(dispatch_result<Args...>(plan_t<Args...>{}));
+
+private:
+    template<std::size_t I>
+    constexpr handler_t<I> handler() const {
+        if constexpr (guarded_case<I>) {
+            return std::get<I>(functors).handler;
+        } else {
+            return std::get<I>(functors);
+        }
+    }
+
+    template<typename... Args>
+    constexpr result_t<Args...> run(unsigned char (&)[N + 1], std::index_sequence<>, Args&&...) const {
+        return std::nullopt;
+    }
+
+    template<typename... Args, std::size_t I, std::size_t... Rest>
+    constexpr result_t<Args...> run(unsigned char (&seen)[N + 1], std::index_sequence<I, Rest...>,
+                                    Args&&... args) const {
+        if constexpr (guarded_case<I>) {
+            constexpr std::size_t slot = guard_slot<I>();
+            if (seen[slot] == 0) {
+                seen[slot] = std::get<I>(functors).pred(args...) ? 2 : 1;
+            }
+            if (seen[slot] == 1) {
+                return run(seen, std::index_sequence<Rest...>{}, std::forward<Args>(args)...);
+            }
+        }
+        if constexpr (std::is_void_v<std::invoke_result_t<handler_t<I>, Args...>>) {
+            handler<I>()(std::forward<Args>(args)...);
+            return std::monostate{};
+        } else {
+            return handler<I>()(std::forward<Args>(args)...);
+        }
+    }
+
+public:
+    constexpr explicit MultiDispatcher(Functors... fs) : functors(std::move(fs)...) {}
+
+    // Walks the reachable cases in order and returns the first whose guard
+    // holds. Variant indices are resolved by the caller's visit.
+    template<typename... Args>
+    constexpr auto operator()(Args&&... args) const -> result_t<Args...> {
+        unsigned char seen[N + 1]{};
+        return run(seen, plan_t<Args...>{}, std::forward<Args>(args)...);
+    }
+};
+
+template<typename... Functors>
+MultiDispatcher(Functors...) -> MultiDispatcher<Functors...>;
+
+// A dispatch table compiled once per binary. Declare it in a header with
+//     extern template struct DispatchUnit<const Handler, const V1, const V2>;
+// and instantiate it in exactly one translation unit with
+//     template struct DispatchUnit<const Handler, const V1, const V2>;
+// Handler must be a named type: lambdas have a distinct type in every TU.
+template<typename F, typename... Variants>
+struct DispatchUnit {
+    static_assert((is_variant_v<std::remove_cv_t<Variants>> && ...));
+
+    using result_type = std::invoke_result_t<F&, decltype(std::get<0>(std::declval<Variants&>()))...>;
+
+    static result_type dispatch(F& f, Variants&... variants);
+};
+
+template<typename F, typename... Variants>
+typename DispatchUnit<F, Variants...>::result_type
+DispatchUnit<F, Variants...>::dispatch(F& f, Variants&... variants) {
+    return multi_visit(f, variants...);
+}
+
+// Always dispatches through DispatchUnit<const F, const Variants...>, so
+// units must be declared with const handler and variant types.
+template<typename F, typename... Variants>
+decltype(auto) visit_unit(const F& f, const Variants&... variants) {
+    return DispatchUnit<const F, const Variants...>::dispatch(f, variants...);
+}
@@ -0,0 +1,21 @@
+module;
+
+#include "multi_visit.hpp"
+
+export module multi_visit;
+
+export using ::overloaded;
+export using ::is_variant;
+export using ::is_variant_v;
+export using ::apply_with_index;
+export using ::multi_visit;
+export using ::multi_visit_tuple;
+export using ::multi_visit_symmetric;
+export using ::tuple_transform;
+export using ::guarded;
+export using ::when;
+export using ::is_guarded;
+export using ::is_guarded_v;
+export using ::MultiDispatcher;
+export using ::DispatchUnit;
+export using ::visit_unit;
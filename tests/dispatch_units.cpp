@@ -0,0 +1,3 @@
+#include "dispatch_units.hpp"
+
+template struct DispatchUnit<const ShapeSizeSum, const Shape, const Shape>;
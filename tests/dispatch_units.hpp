@@ -0,0 +1,19 @@
+#pragma once
+
+#include <variant>
+
+#include "multi_visit.hpp"
+
+struct Circle { double radius; };
+struct Square { double side; };
+
+using Shape = std::variant<Circle, Square>;
+
+struct ShapeSizeSum {
+    double operator()(const Circle& a, const Circle& b) const { return a.radius + b.radius; }
+    double operator()(const Circle& a, const Square& b) const { return a.radius + b.side; }
+    double operator()(const Square& a, const Circle& b) const { return a.side + b.radius; }
+    double operator()(const Square& a, const Square& b) const { return a.side + b.side; }
+};
+
+extern template struct DispatchUnit<const ShapeSizeSum, const Shape, const Shape>;
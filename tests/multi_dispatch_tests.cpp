@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include "multi_visit.hpp"
+#include "dispatch_units.hpp"
 #include <variant>
 #include <tuple>
 #include <utility>
@@ -9,125 +11,6 @@
 #include <memory>
 #include <vector>
 
-template<typename... Ts>
-struct overloaded : Ts... { using Ts::operator()...; };
-
-template<typename... Ts>
-overloaded(Ts...) -> overloaded<Ts...>;
-
-template<typename T>
-struct is_variant : std::false_type {};
-
-template<typename... Ts>
-struct is_variant<std::variant<Ts...>> : std::true_type {};
-
-template<typename T>
-inline constexpr bool is_variant_v = is_variant<T>::value;
-
-template<typename Tuple, typename F, std::size_t... Is>
-constexpr decltype(auto) apply_with_index_impl(F&& f, Tuple&& t, std::index_sequence<Is...>) {
-    return std::forward<F>(f)(std::get<Is>(std::forward<Tuple>(t))...);
-}
-
-template<typename Tuple, typename F>
-constexpr decltype(auto) apply_with_index(F&& f, Tuple&& t) {
-    return apply_with_index_impl(
-        std::forward<F>(f), 
-        std::forward<Tuple>(t),
-        std::make_index_sequence<std::tuple_size_v<std::remove_reference_t<Tuple>>>{}
-    );
-}
-
-template<typename Visitor, typename Tuple, std::size_t I = 0>
-struct VariantTupleVisitor {
-    template<typename... Args>
-    static constexpr decltype(auto) visit(Visitor&& visitor, Tuple&& tuple, Args&&... args) {
-        if constexpr (I == std::tuple_size_v<std::remove_reference_t<Tuple>>) {
-            return std::forward<Visitor>(visitor)(std::forward<Args>(args)...);
-        } else {
-            return std::visit([&](auto&& val) -> decltype(auto) {
-                return VariantTupleVisitor<Visitor, Tuple, I + 1>::visit(
-                    std::forward<Visitor>(visitor),
-                    std::forward<Tuple>(tuple),
-                    std::forward<Args>(args)...,
-                    std::forward<decltype(val)>(val)
-                );
-            }, std::get<I>(std::forward<Tuple>(tuple)));
-        }
-    }
-};
-
-template<typename F, typename... Variants>
-constexpr decltype(auto) multi_visit(F&& f, Variants&&... variants) {
-    static_assert((is_variant_v<std::remove_reference_t<Variants>> && ...));
-    return VariantTupleVisitor<F, std::tuple<Variants...>>::visit(
-        std::forward<F>(f),
-        std::forward_as_tuple(std::forward<Variants>(variants)...)
-    );
-}
-
-template<typename F, typename Tuple>
-constexpr decltype(auto) multi_visit_tuple(F&& f, Tuple&& tuple) {
-    return apply_with_index([&f](auto&&... variants) -> decltype(auto) {
-        return multi_visit(std::forward<F>(f), std::forward<decltype(variants)>(variants)...);
-    }, std::forward<Tuple>(tuple));
-}
-
-template<typename T, typename = void>
-struct has_call_operator : std::false_type {};
-
-template<typename T>
-struct has_call_operator<T, std::void_t<decltype(&T::operator())>> : std::true_type {};
-
-template<typename F, typename... Args>
-struct is_invocable_impl : std::false_type {};
-
-template<typename F, typename... Args>
-struct is_invocable_impl<F, std::enable_if_t<std::is_invocable_v<F, Args...>>, Args...> : std::true_type {};
-
-template<typename Tuple, std::size_t... Is>
-constexpr auto tuple_transform_impl(Tuple&& t, auto&& f, std::index_sequence<Is...>) {
-    return std::make_tuple(f(std::get<Is>(std::forward<Tuple>(t)))...);
-}
-
-template<typename Tuple, typename F>
-constexpr auto tuple_transform(Tuple&& t, F&& f) {
-    return tuple_transform_impl(
-        std::forward<Tuple>(t),
-        std::forward<F>(f),
-        std::make_index_sequence<std::tuple_size_v<std::remove_reference_t<Tuple>>>{}
-    );
-}
-
-template<typename... Functors>
-class MultiDispatcher {
-    std::tuple<Functors...> functors;
-    
-    template<std::size_t I, typename... Args>
-    constexpr auto try_dispatch(Args&&... args) const -> std::optional<int> {
-        if constexpr (I < sizeof...(Functors)) {
-            if constexpr (std::is_invocable_v<decltype(std::get<I>(functors)), Args...>) {
-                return std::get<I>(functors)(std::forward<Args>(args)...);
-            } else {
-                return try_dispatch<I + 1>(std::forward<Args>(args)...);
-            }
-        } else {
-            return std::nullopt;
-        }
-    }
-    
-public:
-    constexpr explicit MultiDispatcher(Functors... fs) : functors(std::move(fs)...) {}
-    
-    template<typename... Args>
-    constexpr auto operator()(Args&&... args) const -> std::optional<int> {
-        return try_dispatch<0>(std::forward<Args>(args)...);
-    }
-};
-
-template<typename... Functors>
-MultiDispatcher(Functors...) -> MultiDispatcher<Functors...>;
-
 struct A { 
     int value; 
     bool operator==(const A& other) const { return value == other.value; }
@@ -527,6 +410,251 @@ TEST_F(MultiDispatchTest, VariadicTemplateExpansion) {
     EXPECT_DOUBLE_EQ(result, 6.0);
 }
 
+TEST_F(MultiDispatchTest, SymmetricDispatchCanonicalOrder) {
+    using V = std::variant<A, B, C>;
+    V a = A{1};
+    V c = C{'Z'};
+
+    auto visitor = overloaded{
+        [](A x, C y, bool swapped) {
+            return std::to_string(x.value) + y.value + (swapped ? "s" : "");
+        },
+        [](auto, auto, bool) { return std::string("other"); }
+    };
+
+    EXPECT_EQ(multi_visit_symmetric(visitor, a, c), "1Z");
+    EXPECT_EQ(multi_visit_symmetric(visitor, c, a), "1Zs");
+}
+
+TEST_F(MultiDispatchTest, SymmetricDispatchInstantiatesUpperTriangleOnly) {
+    using V = std::variant<int, double, char, A>;
+    std::vector<V> values = { 1, 2.0, 'c', A{4} };
+
+    int calls = 0;
+    auto visitor = [&calls](auto x, auto y, bool) {
+        using X = decltype(x);
+        using Y = decltype(y);
+        static_assert(!(std::is_same_v<X, double> && std::is_same_v<Y, int>));
+        static_assert(!(std::is_same_v<X, A> && !std::is_same_v<Y, A>));
+        return ++calls;
+    };
+
+    for (auto& lhs : values) {
+        for (auto& rhs : values) {
+            multi_visit_symmetric(visitor, lhs, rhs);
+        }
+    }
+
+    EXPECT_EQ(calls, 16);
+}
+
+TEST_F(MultiDispatchTest, SymmetricDispatchWithMultiDispatcher) {
+    using V = std::variant<A, B, C>;
+    V a = A{7};
+    V b = B{1.5};
+
+    auto dispatcher = MultiDispatcher{
+        [](A x, B, bool swapped) { return swapped ? -x.value : x.value; },
+        [](auto, auto, bool) { return 0; }
+    };
+
+    auto forward = multi_visit_symmetric(dispatcher, a, b);
+    auto backward = multi_visit_symmetric(dispatcher, b, a);
+
+    EXPECT_EQ(forward.value(), 7);
+    EXPECT_EQ(backward.value(), -7);
+}
+
+TEST_F(MultiDispatchTest, SymmetricDispatchMixedQualifiers) {
+    using V = std::variant<int, char>;
+    V v = 'c';
+    const V cv = 3;
+
+    auto visitor = [](auto lo, auto hi, bool swapped) {
+        return std::to_string(lo) + static_cast<char>(hi) + (swapped ? "s" : "");
+    };
+
+    EXPECT_EQ(multi_visit_symmetric(visitor, v, cv), "3cs");
+    EXPECT_EQ(multi_visit_symmetric(visitor, cv, v), "3c");
+    EXPECT_EQ(multi_visit_symmetric(visitor, v, V{5}), "5cs");
+}
+
+TEST_F(MultiDispatchTest, SymmetricDispatchConstexpr) {
+    using V = std::variant<int, char>;
+
+    constexpr auto test_func = []() {
+        V v1 = 'A';
+        V v2 = 10;
+        return multi_visit_symmetric([](auto lo, auto hi, bool swapped) {
+            return static_cast<int>(lo) * 1000 + static_cast<int>(hi) + (swapped ? 1 : 0);
+        }, v1, v2);
+    };
+
+    static_assert(test_func() == 10065 + 1);
+    EXPECT_EQ(test_func(), 10066);
+}
+
+TEST_F(MultiDispatchTest, ExplicitDispatchUnit) {
+    const ShapeSizeSum sum;
+    const Shape circle = Circle{1.5};
+    const Shape square = Square{2.0};
+
+    EXPECT_DOUBLE_EQ(visit_unit(sum, circle, square), 3.5);
+    EXPECT_DOUBLE_EQ(visit_unit(sum, square, square), 4.0);
+}
+
+TEST_F(MultiDispatchTest, ExplicitDispatchUnitNonConstArguments) {
+    ShapeSizeSum sum;
+    Shape circle = Circle{0.5};
+    Shape square = Square{3.0};
+
+    EXPECT_DOUBLE_EQ(visit_unit(sum, square, circle), 3.5);
+}
+
+TEST_F(MultiDispatchTest, MultiDispatcherPartialWithMultiVisit) {
+    using V1 = std::variant<A, B>;
+    using V2 = std::variant<C, B>;
+
+    auto dispatcher = MultiDispatcher{
+        [](A a, C c) { return a.value + c.value; }
+    };
+
+    V1 a = A{1};
+    V1 b = B{1.0};
+    V2 c = C{'\x02'};
+
+    std::optional<int> matched = multi_visit(dispatcher, a, c);
+    std::optional<int> unmatched = multi_visit(dispatcher, b, c);
+
+    EXPECT_EQ(matched.value(), 3);
+    EXPECT_FALSE(unmatched.has_value());
+}
+
+TEST_F(MultiDispatchTest, MultiDispatcherVoidHandler) {
+    int counter = 0;
+    auto dispatcher = MultiDispatcher{
+        [&counter](int) { counter++; }
+    };
+
+    auto matched = dispatcher(1);
+    auto unmatched = dispatcher("text");
+
+    EXPECT_TRUE(matched.has_value());
+    EXPECT_FALSE(unmatched.has_value());
+    EXPECT_EQ(counter, 1);
+}
+
+struct PositiveGuard {
+    static inline int evaluations = 0;
+    bool operator()(const A& a) const { ++evaluations; return a.value > 0; }
+    bool operator()(const A& a, const auto&) const { return (*this)(a); }
+};
+
+TEST_F(MultiDispatchTest, GuardedCases) {
+    auto dispatcher = MultiDispatcher{
+        when([](A a) { return a.value > 100; }, [](A) { return std::string("large"); }),
+        when([](A a) { return a.value > 0; }, [](A) { return std::string("positive"); }),
+        [](A) { return std::string("other"); }
+    };
+
+    EXPECT_EQ(dispatcher(A{500}).value(), "large");
+    EXPECT_EQ(dispatcher(A{5}).value(), "positive");
+    EXPECT_EQ(dispatcher(A{-5}).value(), "other");
+}
+
+TEST_F(MultiDispatchTest, GuardedCasesNoMatch) {
+    auto dispatcher = MultiDispatcher{
+        when([](A a) { return a.value > 0; }, [](A a) { return a.value; })
+    };
+
+    EXPECT_EQ(dispatcher(A{3}).value(), 3);
+    EXPECT_FALSE(dispatcher(A{-3}).has_value());
+    EXPECT_FALSE(dispatcher(B{1.0}).has_value());
+}
+
+TEST_F(MultiDispatchTest, GuardedCasesWithVariants) {
+    using V1 = std::variant<A, B>;
+    using V2 = std::variant<B, C>;
+
+    auto dispatcher = MultiDispatcher{
+        when([](A a, C) { return a.value > 0; }, [](A, C) { return 1; }),
+        when([](auto&, B b) { return b.value < 0; }, [](auto, B) { return 2; }),
+        [](auto, auto) { return 0; }
+    };
+
+    auto visit = [&dispatcher](const V1& v1, const V2& v2) {
+        return multi_visit(dispatcher, v1, v2).value();
+    };
+
+    EXPECT_EQ(visit(A{1}, C{'c'}), 1);
+    EXPECT_EQ(visit(A{-1}, C{'c'}), 0);
+    EXPECT_EQ(visit(A{1}, B{-2.0}), 2);
+    EXPECT_EQ(visit(B{1.0}, B{2.0}), 0);
+}
+
+TEST_F(MultiDispatchTest, GuardedCasesWithoutFallbackWithVariants) {
+    using V1 = std::variant<A, B>;
+    using V2 = std::variant<B, C>;
+
+    auto dispatcher = MultiDispatcher{
+        when([](A a, C) { return a.value > 0; }, [](A a, C) { return a.value; })
+    };
+
+    V1 positive = A{4};
+    V1 negative = A{-4};
+    V1 other = B{1.0};
+    V2 c = C{'c'};
+
+    std::optional<int> matched = multi_visit(dispatcher, positive, c);
+    std::optional<int> guard_failed = multi_visit(dispatcher, negative, c);
+    std::optional<int> unmatched = multi_visit(dispatcher, other, c);
+
+    EXPECT_EQ(matched.value(), 4);
+    EXPECT_FALSE(guard_failed.has_value());
+    EXPECT_FALSE(unmatched.has_value());
+}
+
+TEST_F(MultiDispatchTest, SharedGuardEvaluatedOnce) {
+    PositiveGuard::evaluations = 0;
+
+    auto dispatcher = MultiDispatcher{
+        when(PositiveGuard{}, [](A, B) { return 1; }),
+        when(PositiveGuard{}, [](A, C) { return 2; }),
+        when(PositiveGuard{}, [](A, auto) { return 3; }),
+        [](auto, auto) { return 0; }
+    };
+
+    EXPECT_EQ(dispatcher(A{-1}, C{'c'}).value(), 0);
+    EXPECT_EQ(PositiveGuard::evaluations, 1);
+
+    EXPECT_EQ(dispatcher(A{1}, C{'c'}).value(), 2);
+    EXPECT_EQ(PositiveGuard::evaluations, 2);
+}
+
+TEST_F(MultiDispatchTest, CasesAfterUnguardedMatchNotInstantiated) {
+    auto dispatcher = MultiDispatcher{
+        when([](int i) { return i < 0; }, [](int) { return 0; }),
+        [](int i) { return i; },
+        [](auto x) { return x.foo; }
+    };
+
+    EXPECT_EQ(dispatcher(3).value(), 3);
+    EXPECT_EQ(dispatcher(-3).value(), 0);
+}
+
+TEST_F(MultiDispatchTest, GuardedCasesConstexpr) {
+    constexpr auto dispatcher = MultiDispatcher{
+        when([](int i) { return i < 0; }, [](int) { return -1; }),
+        when([](int i) { return i == 0; }, [](int) { return 0; }),
+        [](int) { return 1; }
+    };
+
+    static_assert(dispatcher(-7).value() == -1);
+    static_assert(dispatcher(0).value() == 0);
+    static_assert(dispatcher(7).value() == 1);
+    EXPECT_EQ(dispatcher(7).value(), 1);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();